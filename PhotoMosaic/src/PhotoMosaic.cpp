@@ -55,29 +55,38 @@ cv::Mat buildAtlas(const std::vector<cv::Mat>& images, unsigned int side, std::v
     return atlas;
 }
 
+/// Copy the slots of an atlas into a larger atlas with a different number of columns.
+/// The new slots are empty (white).
+cv::Mat growAtlas(const cv::Mat& atlas, unsigned int side, unsigned int slots, unsigned int columns,
+                  unsigned int grownColumns, unsigned int grownRows) {
+    cv::Mat grown(grownRows * side, grownColumns * side, CV_8UC3, cv::Scalar(255, 255, 255));
+    for(unsigned int slot = 0; slot < slots; slot++) {
+        cv::Rect src((slot % columns) * side, (slot / columns) * side, side, side);
+        cv::Rect dst((slot % grownColumns) * side, (slot / grownColumns) * side, side, side);
+        atlas(src).copyTo(grown(dst));
+    }
+    return grown;
+}
 
-cv::Mat getMean(const std::vector<cv::Mat>& mats) {
+cv::Mat getSum(const std::vector<cv::Mat>& mats) {
     cv::Mat sum = cv::Mat::zeros(mats[0].rows, mats[0].cols, CV_32FC3);
     cv::Mat matf;
     for(auto& mat : mats) {
         mat.convertTo(matf, CV_32FC3);
         cv::add(matf, sum, sum);
     }
-    sum /= mats.size();
     return sum;
 }
 
-/// Subtract the mean of a set of cv::Mats from each of those cv::Mats.
+/// Subtract a mean from a cv::Mat, returning a new cv::Mat.
 /// "0" is treated as "127", acting similarly to a highpass filter.
-void subtractMean(std::vector<cv::Mat>& mats) {
-    cv::Mat mean = getMean(mats);
-    cv::Mat matf;
-    for(auto& mat : mats) {
-        mat.convertTo(matf, CV_32FC3);
-        cv::subtract(matf, mean, matf);
-        matf += cv::Scalar(127, 127, 127);
-        matf.convertTo(mat, CV_8UC3);
-    }
+cv::Mat subtractMean(const cv::Mat& mat, const cv::Mat& mean) {
+    cv::Mat matf, centered;
+    mat.convertTo(matf, CV_32FC3);
+    cv::subtract(matf, mean, matf);
+    matf += cv::Scalar(127, 127, 127);
+    matf.convertTo(centered, CV_8UC3);
+    return centered;
 }
 
 /// Batch resize a collection of cv::Mat images to be size (side x side).
@@ -123,6 +132,113 @@ float clip(float t, float lower, float upper) {
     return std::max(lower, std::min(t, upper));
 }
 
+/// Average standard deviation across the channels of a cv::Mat.
+/// After the highpass filter this is a measure of how much detail there is.
+float getDetail(const cv::Mat& mat) {
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(mat, mean, stddev);
+    return (stddev[0] + stddev[1] + stddev[2]) / 3;
+}
+
+void PhotoMosaic::addCells(int x, int y, int level, float threshold, std::vector<std::vector<cv::Point2i>>& cells) const {
+    if(x >= nx || y >= ny) {
+        return;
+    }
+    int span = 1 << level;
+    bool split = level > 0 &&
+    (x + span > nx || y + span > ny ||
+     getDetail(dst(cv::Rect(x * subsampling, y * subsampling, span * subsampling, span * subsampling))) > threshold);
+    if(split) {
+        int half = span / 2;
+        addCells(x, y, level - 1, threshold, cells);
+        addCells(x + half, y, level - 1, threshold, cells);
+        addCells(x, y + half, level - 1, threshold, cells);
+        addCells(x + half, y + half, level - 1, threshold, cells);
+    } else {
+        cells[level].emplace_back(x * side, y * side);
+    }
+}
+
+void PhotoMosaic::setLayout(const Layout& layout) {
+    std::vector<int> previousOffsets = levelOffsets;
+    std::vector<cv::Point2i> previousPositions = endPositions;
+    
+    screenPositions.clear();
+    tileLevels.clear();
+    tileIcons.clear();
+    levelOffsets.assign(1, 0);
+    for(int level = 0; level < levels; level++) {
+        const std::vector<unsigned int>& icons = layout.icons[level];
+        unsigned int i = 0;
+        for(const cv::Point2i& cell : layout.cells[level]) {
+            unsigned int icon = icons[i];
+            // icons removed after the layout was matched are swapped for one still in use
+            if(iconOrder[icon] < 0) {
+                icon = activeIcons[i % activeIcons.size()];
+            }
+            screenPositions.push_back(cell);
+            tileLevels.push_back(level);
+            tileIcons.push_back(icon);
+            i++;
+        }
+        levelOffsets.push_back(screenPositions.size());
+    }
+    n = screenPositions.size();
+    
+    // a removed icon's slot can be reused once a layout matched after the removal
+    // is applied. older layouts, which may still be inside a Pipeline, are never
+    // applied after a newer one, so none of them can refer to the slot anymore.
+    unsigned int kept = 0;
+    for(const std::pair<unsigned int, unsigned int>& retired : retiredSlots) {
+        if(layout.generation >= retired.second) {
+            freeSlots.push_back(retired.first);
+        } else {
+            retiredSlots[kept++] = retired;
+        }
+    }
+    retiredSlots.resize(kept);
+    
+    // endPositions holds where each tile is now, the start of the next transition.
+    endPositions = screenPositions;
+    if(previousOffsets.size() == levelOffsets.size()) {
+        // find which old tile covered each grid cell
+        std::vector<int> previousCover(nx * ny, -1);
+        for(int level = 0; level < levels; level++) {
+            int span = 1 << level;
+            for(int i = previousOffsets[level]; i < previousOffsets[level + 1]; i++) {
+                int x = previousPositions[i].x / side, y = previousPositions[i].y / side;
+                for(int cy = y; cy < std::min(y + span, ny); cy++) {
+                    for(int cx = x; cx < std::min(x + span, nx); cx++) {
+                        previousCover[cy * nx + cx] = i;
+                    }
+                }
+            }
+        }
+        for(int level = 0; level < levels; level++) {
+            int previousCount = previousOffsets[level + 1] - previousOffsets[level];
+            int count = levelOffsets[level + 1] - levelOffsets[level];
+            for(int i = 0; i < count; i++) {
+                int index = levelOffsets[level] + i;
+                if(i < previousCount) {
+                    endPositions[index] = previousPositions[previousOffsets[level] + i];
+                } else {
+                    // a new tile starts where the old tile covering its cell was, which is
+                    // the parent or a child of its cell, instead of popping in at its cell.
+                    // it still changes size at the start of the transition.
+                    const cv::Point2i& cell = screenPositions[index];
+                    int cover = previousCover[(cell.y / side) * nx + cell.x / side];
+                    if(cover >= 0) {
+                        endPositions[index] = previousPositions[cover];
+                    }
+                }
+            }
+        }
+    }
+    beginPositions = endPositions;
+    transitionBegin.assign(n, 0);
+    transitionEnd.assign(n, 1);
+}
+
 void PhotoMosaic::setup(int width, int height, int side, int subsampling) {
     if(subsampling < 1 || subsampling > 5) {
         throw std::out_of_range("subsampling is out of range");
@@ -147,14 +263,14 @@ void PhotoMosaic::setRefinementSteps(int refinementSteps) {
     if(refinementSteps < 0 || refinementSteps > 10000000) {
         throw std::out_of_range("refinementSteps is out of range");
     }
-    matcher.setRefinementSteps(refinementSteps);
+    this->refinementSteps = refinementSteps;
 }
 
 void PhotoMosaic::setMaximumDuration(float maximumDurationSeconds) {
     if(maximumDurationSeconds < 0 || maximumDurationSeconds > 10) {
         throw std::out_of_range("maximumDurationSeconds is out of range");
     }
-    matcher.setMaximumDuration(maximumDurationSeconds);
+    this->maximumDurationSeconds = maximumDurationSeconds;
 }
 
 void PhotoMosaic::setFilterScale(float filterScale) {
@@ -171,6 +287,23 @@ void PhotoMosaic::setFilterContrast(float filterContrast) {
     highpass.setFilterContrast(filterContrast);
 }
 
+void PhotoMosaic::setLevels(int levels) {
+    if(levels < 1 || levels > 4) {
+        throw std::out_of_range("levels is out of range");
+    }
+    if(!atlases.empty()) {
+        throw std::logic_error("setLevels() must be called before setIcons()");
+    }
+    this->levels = levels;
+}
+
+void PhotoMosaic::setDetailThreshold(float detailThreshold) {
+    if(detailThreshold < 0 || detailThreshold > 10) {
+        throw std::out_of_range("detailThreshold is out of range");
+    }
+    this->detailThreshold = detailThreshold;
+}
+
 void PhotoMosaic::setTransitionStyle(bool topDown, bool circle, bool manhattan) {
     transitionTopDown = topDown;
     transitionCircle = circle;
@@ -181,26 +314,199 @@ void PhotoMosaic::setIcons(const std::vector<cv::Mat>& icons) {
     if(icons.empty()) {
         throw std::invalid_argument("no icons");
     }
-    atlas = buildAtlas(icons, side, atlasPositions);
-    std::vector<cv::Mat> smaller = batchResize(icons, subsampling);
-    subtractMean(smaller);
-    unsigned int i = 0;
+    if(ceilf(sqrtf(icons.size())) * (side << (levels - 1)) > maximumAtlasSize) {
+        throw std::length_error("too many icons for the maximum atlas size");
+    }
+    std::lock_guard<std::mutex> lock(iconMutex);
+    atlases.resize(levels);
+    atlasPositions.resize(levels);
+    for(int level = 0; level < levels; level++) {
+        atlases[level] = buildAtlas(icons, side << level, atlasPositions[level]);
+    }
+    atlasColumns = ceilf(sqrtf(icons.size()));
+    
+    // the rest of the last atlas row is free for addIcon()
+    unsigned int slots = atlasPositions[0].size();
+    unsigned int capacity = ((slots + atlasColumns - 1) / atlasColumns) * atlasColumns;
+    for(int level = 0; level < levels; level++) {
+        int tileSide = side << level;
+        for(unsigned int slot = slots; slot < capacity; slot++) {
+            atlasPositions[level].emplace_back((slot % atlasColumns) * tileSide, (slot / atlasColumns) * tileSide);
+        }
+    }
+    freeSlots.clear();
+    for(unsigned int slot = capacity; slot > slots; slot--) {
+        freeSlots.push_back(slot - 1);
+    }
+    retiredSlots.clear();
+    newIcons.clear();
+    
+    iconSmall = batchResize(icons, subsampling);
+    iconSum = getSum(iconSmall);
+    centeredMean = iconSum / iconSmall.size();
+    iconTiles.clear();
+    activeIcons.clear();
+    iconOrder.assign(capacity, -1);
+    for(unsigned int i = 0; i < slots; i++) {
+        iconTiles.emplace_back(subtractMean(iconSmall[i], centeredMean));
+        activeIcons.push_back(i);
+        iconOrder[i] = i;
+    }
+    
+    // start with every tile at the smallest level
+    Layout layout;
+    layout.cells.resize(levels);
+    layout.icons.resize(levels);
+    layout.generation = iconGeneration;
     for(int y = 0; y < ny; y++) {
         for(int x = 0; x < nx; x++) {
-            screenPositions.emplace_back(x*side, y*side);
-            unsigned int index = i % smaller.size();
-            srcTiles.emplace_back(smaller[index]);
-            i++;
+            addCells(x, y, 0, 0, layout.cells);
+            layout.icons[0].push_back(activeIcons[layout.icons[0].size() % slots]);
         }
     }
+    levelIcons = layout.icons;
+    replaceCursors.assign(levels, 0);
+    levelOffsets.clear();
+    endPositions.clear();
+    setLayout(layout);
+}
+
+unsigned int PhotoMosaic::addIcon(const cv::Mat& icon) {
+    if(icon.empty()) {
+        throw std::invalid_argument("icon is empty");
+    }
+    if(icon.channels() != 3) {
+        throw std::invalid_argument("icon is not 3 channels");
+    }
+    if(atlases.empty()) {
+        throw std::logic_error("setIcons() must be called before addIcon()");
+    }
+    if(icon.rows != icon.cols) {
+        std::cerr << "icon is not square, stretching to fit" << std::endl;
+    }
     
-    beginPositions = screenPositions;
-    endPositions = screenPositions;
-    transitionBegin.assign(n, 0);
-    transitionEnd.assign(n, 1);
+    std::lock_guard<std::mutex> lock(iconMutex);
+    if(freeSlots.empty()) {
+        growAtlases();
+    }
+    unsigned int slot = freeSlots.back();
+    freeSlots.pop_back();
+    for(int level = 0; level < levels; level++) {
+        int tileSide = side << level;
+        const cv::Point2i& position = atlasPositions[level][slot];
+        cv::Mat roi(atlases[level], cv::Rect(position.x, position.y, tileSide, tileSide));
+        cv::resize(icon, roi, cv::Size(tileSide, tileSide), 0, 0, cv::INTER_AREA);
+    }
+    
+    cv::Mat small, smallf;
+    cv::resize(icon, small, cv::Size(subsampling, subsampling), 0, 0, cv::INTER_AREA);
+    small.convertTo(smallf, CV_32FC3);
+    
+    iconSum += smallf;
+    iconOrder[slot] = activeIcons.size();
+    activeIcons.push_back(slot);
+    iconSmall.push_back(small);
+    iconTiles.emplace_back(subtractMean(small, centeredMean));
+    newIcons.push_back(slot);
+    updateMean();
+    return slot;
+}
+
+void PhotoMosaic::removeIcon(unsigned int icon) {
+    if(icon >= iconOrder.size() || iconOrder[icon] < 0) {
+        throw std::invalid_argument("icon is not in use");
+    }
+    if(activeIcons.size() == 1) {
+        throw std::logic_error("cannot remove the last icon");
+    }
+    
+    std::lock_guard<std::mutex> lock(iconMutex);
+    unsigned int index = iconOrder[icon];
+    cv::Mat smallf;
+    iconSmall[index].convertTo(smallf, CV_32FC3);
+    iconSum -= smallf;
+    
+    // move the last icon into the removed icon's place
+    unsigned int last = activeIcons.size() - 1;
+    activeIcons[index] = activeIcons[last];
+    iconSmall[index] = iconSmall[last];
+    iconTiles[index] = iconTiles[last];
+    iconOrder[activeIcons[index]] = index;
+    activeIcons.pop_back();
+    iconSmall.pop_back();
+    iconTiles.pop_back();
+    iconOrder[icon] = -1;
+    
+    // tiles on screen, and layouts in a Pipeline, may still use this icon
+    iconGeneration++;
+    retiredSlots.emplace_back(icon, iconGeneration);
+    updateMean();
+}
+
+void PhotoMosaic::growAtlases() {
+    // keep the atlas square, so it reaches the maximum size as late as possible
+    unsigned int capacity = iconOrder.size();
+    unsigned int grownColumns = ceilf(sqrtf(2 * capacity));
+    unsigned int grownRows = (2 * capacity + grownColumns - 1) / grownColumns;
+    unsigned int grown = grownColumns * grownRows;
+    int topSide = side << (levels - 1);
+    if(grownColumns * topSide > unsigned(maximumAtlasSize) || grownRows * topSide > unsigned(maximumAtlasSize)) {
+        throw std::length_error("atlas is full, remove icons or raise the maximum atlas size");
+    }
+    for(int level = 0; level < levels; level++) {
+        int tileSide = side << level;
+        atlases[level] = growAtlas(atlases[level], tileSide, capacity, atlasColumns, grownColumns, grownRows);
+        atlasPositions[level].clear();
+        for(unsigned int slot = 0; slot < grown; slot++) {
+            atlasPositions[level].emplace_back((slot % grownColumns) * tileSide, (slot / grownColumns) * tileSide);
+        }
+    }
+    atlasColumns = grownColumns;
+    for(unsigned int slot = grown; slot > capacity; slot--) {
+        freeSlots.push_back(slot - 1);
+    }
+    iconOrder.resize(grown, -1);
+}
+
+unsigned int PhotoMosaic::nextIcon(unsigned int i) {
+    while(!newIcons.empty()) {
+        unsigned int icon = newIcons.front();
+        newIcons.pop_front();
+        if(iconOrder[icon] >= 0) {
+            return icon;
+        }
+    }
+    return activeIcons[i % activeIcons.size()];
+}
+
+void PhotoMosaic::setMaximumAtlasSize(int maximumAtlasSize) {
+    if(maximumAtlasSize < 1) {
+        throw std::out_of_range("maximumAtlasSize is out of range");
+    }
+    this->maximumAtlasSize = maximumAtlasSize;
+}
+
+void PhotoMosaic::updateMean() {
+    cv::Mat mean = iconSum / activeIcons.size();
+    // only recenter every descriptor once the mean has drifted noticeably
+    float recenterTolerance = 2;
+    if(cv::norm(mean, centeredMean, cv::NORM_INF) < recenterTolerance) {
+        return;
+    }
+    centeredMean = mean;
+    for(unsigned int i = 0; i < iconSmall.size(); i++) {
+        iconTiles[i] = Tile(subtractMean(iconSmall[i], centeredMean));
+    }
 }
 
 void PhotoMosaic::match(const cv::Mat& mat) {
+    Layout layout;
+    prepare(mat, layout);
+    match(layout);
+    apply(layout);
+}
+
+void PhotoMosaic::prepare(const cv::Mat& mat, Layout& layout) {
     if(mat.empty()) {
         throw std::invalid_argument("mat is empty");
     }
@@ -215,9 +521,100 @@ void PhotoMosaic::match(const cv::Mat& mat) {
     cv::resize(crop, dst, cv::Size(w, h), 0, 0, cv::INTER_AREA);
     
     highpass.filter(dst);
-    std::vector<Tile> dstTiles = Tile::buildTiles(dst, subsampling);
     
-    matchedIndices = matcher.match(srcTiles, dstTiles);
+    // split the screen into a quadtree, keeping large tiles where the highpass is flat
+    int top = levels - 1;
+    int block = 1 << top;
+    float threshold = detailThreshold * getDetail(dst);
+    layout.cells.resize(levels);
+    for(std::vector<cv::Point2i>& cells : layout.cells) {
+        cells.clear();
+    }
+    for(int y = 0; y < ny; y += block) {
+        for(int x = 0; x < nx; x += block) {
+            addCells(x, y, top, threshold, layout.cells);
+        }
+    }
+    
+    layout.tiles.resize(levels);
+    std::vector<cv::Rect> regions;
+    for(int level = 0; level < levels; level++) {
+        int span = subsampling << level;
+        regions.clear();
+        for(const cv::Point2i& cell : layout.cells[level]) {
+            regions.emplace_back(cell.x / side * subsampling, cell.y / side * subsampling, span, span);
+        }
+        Tile::buildTiles(dst, subsampling, regions, layout.tiles[level]);
+    }
+}
+
+void PhotoMosaic::match(Layout& layout) {
+    unsigned int total = 0;
+    for(const std::vector<Tile>& tiles : layout.tiles) {
+        total += tiles.size();
+    }
+    
+    // pick the icons for every level at once, since icons may be added or
+    // removed from another thread. tile i at a level keeps its icon between
+    // matches, so only tiles whose icon changes swap picture in place.
+    std::vector<std::vector<Tile>> srcTiles(levels);
+    layout.icons.resize(levels);
+    {
+        std::lock_guard<std::mutex> lock(iconMutex);
+        layout.generation = iconGeneration;
+        for(int level = 0; level < levels; level++) {
+            std::vector<unsigned int>& icons = levelIcons[level];
+            unsigned int count = layout.tiles[level].size();
+            unsigned int previousCount = std::min<unsigned int>(icons.size(), count);
+            icons.resize(count);
+            // new tiles at this level, and tiles whose icon was removed, get a new icon
+            for(unsigned int i = 0; i < count; i++) {
+                if(i >= previousCount || iconOrder[icons[i]] < 0) {
+                    icons[i] = nextIcon(i);
+                }
+            }
+            // bring in a limited number of newly added icons per match
+            unsigned int replacements = std::max(1u, count / 32);
+            for(unsigned int r = 0; r < replacements && !newIcons.empty() && count > 0; r++) {
+                unsigned int& cursor = replaceCursors[level];
+                cursor = (cursor + 1) % count;
+                icons[cursor] = nextIcon(cursor);
+            }
+            layout.icons[level] = icons;
+            srcTiles[level].clear();
+            for(unsigned int icon : icons) {
+                srcTiles[level].push_back(iconTiles[iconOrder[icon]]);
+            }
+        }
+    }
+    
+    // each level is matched separately, sharing the matching budget by tile count
+    layout.indices.resize(levels);
+    for(int level = 0; level < levels; level++) {
+        const std::vector<Tile>& dstLevel = layout.tiles[level];
+        const std::vector<Tile>& srcLevel = srcTiles[level];
+        unsigned int count = dstLevel.size();
+        if(count == 0) {
+            layout.indices[level].clear();
+            continue;
+        }
+        float share = float(count) / total;
+        matcher.setRefinementSteps(refinementSteps * share);
+        matcher.setMaximumDuration(maximumDurationSeconds * share);
+        layout.indices[level] = matcher.match(srcLevel, dstLevel);
+    }
+}
+
+void PhotoMosaic::apply(const Layout& layout) {
+    setLayout(layout);
+    matchedIndices.resize(n);
+    for(int level = 0; level < levels; level++) {
+        int begin = levelOffsets[level];
+        const std::vector<unsigned int>& indices = layout.indices[level];
+        for(unsigned int i = 0; i < indices.size(); i++) {
+            matchedIndices[begin + i] = begin + indices[i];
+        }
+    }
     
     // setup the transition timings
     cv::Point2i center(width / 2, height / 2);
@@ -248,10 +645,12 @@ void PhotoMosaic::match(const cv::Mat& mat) {
 cv::Mat PhotoMosaic::buildResult() const {
     cv::Mat screen(height, width, CV_8UC3);
     for(int i = 0; i < n; i++) {
+        int level = tileLevels[i];
+        int tileSide = side << level;
         const cv::Point2i& screenPosition = endPositions[i];
-        const cv::Point2i& atlasPosition = atlasPositions[i % atlasPositions.size()];
-        cv::Mat atlasRoi(atlas(cv::Rect(atlasPosition.x, atlasPosition.y, side, side)));
-        cv::Mat screenRoi(screen(cv::Rect(screenPosition.x, screenPosition.y, side, side)));
+        const cv::Point2i& atlasPosition = atlasPositions[level][tileIcons[i]];
+        cv::Mat atlasRoi(atlases[level](cv::Rect(atlasPosition.x, atlasPosition.y, tileSide, tileSide)));
+        cv::Mat screenRoi(screen(cv::Rect(screenPosition.x, screenPosition.y, tileSide, tileSide)));
         atlasRoi.copyTo(screenRoi);
     }
     return screen;
@@ -259,16 +658,25 @@ cv::Mat PhotoMosaic::buildResult() const {
 
 int PhotoMosaic::getWidth() const { return width; }
 int PhotoMosaic::getHeight() const { return height; }
-int PhotoMosaic::getSide() const { return side; }
+int PhotoMosaic::getSide(int level) const { return side << level; }
 int PhotoMosaic::getSubsampling() const { return subsampling; }
+int PhotoMosaic::getLevels() const { return levels; }
 
-const cv::Mat& PhotoMosaic::getAtlas() const { return atlas; }
-const std::vector<cv::Point2i>& PhotoMosaic::getAtlasPositions() const { return atlasPositions; }
+const cv::Mat& PhotoMosaic::getAtlas(int level) const { return atlases[level]; }
+const std::vector<cv::Point2i>& PhotoMosaic::getAtlasPositions(int level) const { return atlasPositions[level]; }
+const std::vector<int>& PhotoMosaic::getTileLevels() const { return tileLevels; }
+const std::vector<unsigned int>& PhotoMosaic::getTileIcons() const { return tileIcons; }
 const std::vector<cv::Point2i>& PhotoMosaic::getScreenPositions() const { return screenPositions; }
 
 std::vector<cv::Point2f> PhotoMosaic::getCurrentPositions(float t) const {
+    std::vector<cv::Point2f> currentPositions;
+    getCurrentPositions(t, currentPositions);
+    return currentPositions;
+}
+
+void PhotoMosaic::getCurrentPositions(float t, std::vector<cv::Point2f>& currentPositions) const {
     t = clip(t, 0, 1);
-    std::vector<cv::Point2f> currentPositions(n);
+    currentPositions.resize(n);
     for(int i = 0; i < n; i++) {
         const cv::Point2i& begin = beginPositions[i], end = endPositions[i];
         float tb = transitionBegin[i], te = transitionEnd[i];
@@ -278,5 +686,4 @@ std::vector<cv::Point2f> PhotoMosaic::getCurrentPositions(float t) const {
         manhattanLerp(begin, end, smoothstep(curt)) :
         euclideanLerp(begin, end, smoothstep(curt));
     }
-    return currentPositions;
 }
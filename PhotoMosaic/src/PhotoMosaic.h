@@ -2,6 +2,22 @@
 
 #include "Matcher.h"
 #include "Highpass.h"
+#include <deque>
+#include <mutex>
+
+/// A Layout carries one image through the stages of PhotoMosaic::match().
+/// prepare() fills the cells and target tiles for each level, match() fills
+/// the icons and indices, and apply() starts the transition. When a Layout
+/// is passed through the stages again its vectors keep their capacity, but
+/// the tile descriptors and indices are rebuilt for every image.
+class Layout {
+public:
+    std::vector<std::vector<cv::Point2i>> cells;
+    std::vector<std::vector<Tile>> tiles;
+    std::vector<std::vector<unsigned int>> icons;
+    std::vector<std::vector<unsigned int>> indices;
+    unsigned int generation = 0;
+};
 
 /// PhotoMosaic is composed of the Matcher and Highpass classes
 /// and handles interaction between these classes.
@@ -10,15 +26,42 @@ private:
     int side = 0, subsampling = 0;
     int width = 0, height = 0;
     int nx = 0, ny = 0, n = 0;
+    int levels = 1;
+    float detailThreshold = 0.5;
+    unsigned int refinementSteps = 1000000;
+    float maximumDurationSeconds = 1;
     
     Matcher matcher;
     Highpass highpass;
     cv::Mat dst;
     
-    cv::Mat atlas;
-    std::vector<cv::Point2i> atlasPositions;
-    std::vector<Tile> srcTiles;
+    std::vector<cv::Mat> atlases;
+    std::vector<std::vector<cv::Point2i>> atlasPositions;
+    int atlasColumns = 0;
+    int maximumAtlasSize = 8192;
+    
+    // icons are identified by their atlas slot. activeIcons lists the slots
+    // in use, and iconSmall and iconTiles follow the same order.
+    std::mutex iconMutex;
+    std::vector<unsigned int> activeIcons;
+    std::vector<int> iconOrder;
+    // removed slots wait in retiredSlots with the icon generation of their
+    // removal, until a layout matched after it is applied.
+    std::vector<unsigned int> freeSlots;
+    std::vector<std::pair<unsigned int, unsigned int>> retiredSlots;
+    unsigned int iconGeneration = 0;
+    // the icon of each tile at each level, kept between matches. newIcons
+    // waits for tiles, replacing a few per match starting at replaceCursors.
+    std::vector<std::vector<unsigned int>> levelIcons;
+    std::vector<unsigned int> replaceCursors;
+    std::deque<unsigned int> newIcons;
+    std::vector<cv::Mat> iconSmall;
+    std::vector<Tile> iconTiles;
+    cv::Mat iconSum, centeredMean;
     std::vector<cv::Point2i> screenPositions;
+    std::vector<int> levelOffsets;
+    std::vector<int> tileLevels;
+    std::vector<unsigned int> tileIcons;
     std::vector<unsigned int> matchedIndices;
     
     std::vector<cv::Point2i> beginPositions, endPositions;
@@ -27,11 +70,35 @@ private:
     bool transitionCircle = false;
     bool transitionManhattan = false;
     
+    /// Recursively add the quadtree cells of a block at (x, y) in grid units.
+    /// Blocks that overflow the grid or have more detail than the threshold
+    /// are split into four smaller blocks, down to level 0.
+    void addCells(int x, int y, int level, float threshold, std::vector<std::vector<cv::Point2i>>& cells) const;
+    
+    /// Replace the screen layout with the cells and icons of a Layout.
+    /// Tiles that exist at the same level before and after keep their
+    /// current position, so the next transition starts from there.
+    /// Tiles that are new at their level start from the old tile that
+    /// covered their cell, and tiles that no longer fit a level vanish.
+    void setLayout(const Layout& layout);
+    
+    /// Double the number of slots in every atlas level, keeping it square.
+    /// Existing slots keep their icon but move to new positions.
+    void growAtlases();
+    
+    /// The icon for tile i when it needs a new one: the oldest added icon
+    /// that is not shown yet, otherwise icons in turn. Needs iconMutex.
+    unsigned int nextIcon(unsigned int i);
+    
+    /// Update the mean icon after adding or removing an icon, and recenter
+    /// the icon tiles if it has drifted too far from the mean they use.
+    void updateMean();
+    
 public:
     
     /// Before using PhotoMosaic, you must call setup()
     /// Optionally, you may also set options with setRefinementSteps(),
-    /// setFilterScale(), setFilterContrast(), or setTransitionStyle().
+    /// setFilterScale(), setFilterContrast(), setLevels() or setTransitionStyle().
     /// And then load the icons with setIcons().
     void setup(int width, int height, int side=32, int subsampling=3);
     void setRefinementSteps(int refinementSteps);
@@ -39,36 +106,82 @@ public:
     void setFilterScale(float filterScale);
     void setFilterContrast(float filterContrast);
     
+    /// The largest width or height of an atlas, GL_MAX_TEXTURE_SIZE when
+    /// the atlases are used as textures. Defaults to 8192.
+    void setMaximumAtlasSize(int maximumAtlasSize);
+    
+    /// With more than one level, match() uses an adaptive layout: tiles
+    /// at level l are (side << l) pixels wide, and flat regions of the
+    /// image are covered by larger tiles. Must be called before setIcons(),
+    /// which builds one atlas per level, otherwise it throws.
+    void setLevels(int levels);
+    
+    /// detailThreshold is relative to the detail of the whole image,
+    /// lower values give more small tiles. Should be between 0 to 10.
+    void setDetailThreshold(float detailThreshold);
+    
     /// This can also be called before every match() to change the style.
     void setTransitionStyle(bool topDown, bool circle, bool manhattan);
     
     /// setIcons() will automatically resize images as necessary,
     /// but it assumes that the images are square. If they are not
-    /// square, they will be stretched/squashed to fit.
+    /// square, they will be stretched/squashed to fit. Throws
+    /// std::length_error if the atlases would exceed the maximum atlas size.
     void setIcons(const std::vector<cv::Mat>& icons);
     
+    /// addIcon() and removeIcon() change the icons after setIcons(), in amortized
+    /// time proportional to the number of icons changed. Occasionally a change
+    /// costs time proportional to all the icons: when the mean icon drifts and
+    /// every icon tile is recentered, or when addIcon() runs out of slots and
+    /// the atlases double in size, which also moves the atlas positions.
+    /// addIcon() throws std::length_error when the atlas of the largest level
+    /// would grow past the maximum atlas size.
+    /// addIcon() returns the new icon, which is its index into
+    /// getAtlasPositions(). Each tile keeps its icon between matches: tiles
+    /// showing a removed icon get a new one at the next match(), and added
+    /// icons replace the icons of a few tiles per level on every match().
+    /// Call these from the same thread as apply(), they are safe to use
+    /// while a Pipeline is running.
+    unsigned int addIcon(const cv::Mat& icon);
+    void removeIcon(unsigned int icon);
+    
     /// After setting up the PhotoMosaic, call match() on an image.
     /// If the image does not match the size or aspect ratio, then
     /// match() will automatically crop into the image.
+    /// Tiles are only matched against other tiles of the same level.
     void match(const cv::Mat& mat);
     
+    /// match() is made of three stages, which may each run on their own
+    /// thread to process a stream of images (see Pipeline). prepare() uses
+    /// the highpass filter, match() uses the matcher, and apply() changes
+    /// the tiles on screen so it should be called from the drawing thread.
+    void prepare(const cv::Mat& mat, Layout& layout);
+    void match(Layout& layout);
+    void apply(const Layout& layout);
+    
     
     /// Build an image of the finished Photomosaic.
     cv::Mat buildResult() const;
     
     int getWidth() const;
     int getHeight() const;
-    int getSide() const;
+    int getSide(int level=0) const;
     int getSubsampling() const;
+    int getLevels() const;
     
     /// The atlas contains a subsection for each icon. This should be
     /// loaded into a texture for rendering a lot of images without
-    /// doing a context switch on the GPU.
-    const cv::Mat& getAtlas() const;
-    const std::vector<cv::Point2i>& getAtlasPositions() const;
+    /// doing a context switch on the GPU. There is one atlas per level.
+    const cv::Mat& getAtlas(int level=0) const;
+    const std::vector<cv::Point2i>& getAtlasPositions(int level=0) const;
+    
+    /// Each of the tiles has a level and an icon, which together
+    /// select the subsection of the atlas used to draw it.
+    const std::vector<int>& getTileLevels() const;
+    const std::vector<unsigned int>& getTileIcons() const;
     
     /// Each of the tiles has a screen-based position.
-    /// getScreenPositions() returns the original positions on screen.
+    /// getScreenPositions() returns the positions of the current layout.
     const std::vector<cv::Point2i>& getScreenPositions() const;
     
     /// getCurrentPositions(float t) returns the positions on screen
@@ -76,4 +189,7 @@ public:
     /// this version versions floating point positions, and the other
     /// returns integer positions.
     std::vector<cv::Point2f> getCurrentPositions(float t) const;
+    
+    /// Same as getCurrentPositions(float t), reusing a vector.
+    void getCurrentPositions(float t, std::vector<cv::Point2f>& currentPositions) const;
 };
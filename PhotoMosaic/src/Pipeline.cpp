@@ -0,0 +1,100 @@
+#include "Pipeline.h"
+
+Pipeline::Pipeline(PhotoMosaic& photomosaic)
+:photomosaic(photomosaic)
+,running(false)
+,liveThreads(0)
+,droppedFrames(0) {
+}
+
+Pipeline::~Pipeline() {
+    stop();
+}
+
+void Pipeline::start(std::function<bool(cv::Mat&)> capture) {
+    if(isRunning()) {
+        throw std::logic_error("pipeline is already running");
+    }
+    stop(); // join the threads of a stream that ended by itself
+    this->capture = capture;
+    captured.open();
+    prepared.open();
+    matched.open();
+    droppedFrames = 0;
+    running = true;
+    liveThreads = 3;
+    captureThread = std::thread(&Pipeline::captureLoop, this);
+    prepareThread = std::thread(&Pipeline::prepareLoop, this);
+    matchThread = std::thread(&Pipeline::matchLoop, this);
+}
+
+void Pipeline::stop() {
+    running = false;
+    // closing the first slot lets every stage finish in order
+    captured.close();
+    if(captureThread.joinable()) captureThread.join();
+    if(prepareThread.joinable()) prepareThread.join();
+    if(matchThread.joinable()) matchThread.join();
+}
+
+bool Pipeline::isRunning() const {
+    return liveThreads > 0;
+}
+
+void Pipeline::captureLoop() {
+    cv::Mat frame;
+    while(running && capture(frame)) {
+        if(captured.put(frame)) {
+            droppedFrames++;
+        }
+    }
+    running = false;
+    captured.close();
+    liveThreads--;
+}
+
+void Pipeline::prepareLoop() {
+    cv::Mat frame;
+    Layout layout;
+    while(captured.take(frame)) {
+        try {
+            photomosaic.prepare(frame, layout);
+        } catch(const std::exception& e) {
+            std::cerr << "skipping frame: " << e.what() << std::endl;
+            continue;
+        }
+        if(prepared.put(layout)) {
+            droppedFrames++;
+        }
+    }
+    prepared.close();
+    liveThreads--;
+}
+
+void Pipeline::matchLoop() {
+    Layout layout;
+    while(prepared.take(layout)) {
+        photomosaic.match(layout);
+        if(matched.put(layout)) {
+            droppedFrames++;
+        }
+    }
+    matched.close();
+    liveThreads--;
+}
+
+bool Pipeline::isMatchReady() {
+    return matched.isFull();
+}
+
+bool Pipeline::update() {
+    if(!matched.tryTake(current)) {
+        return false;
+    }
+    photomosaic.apply(current);
+    return true;
+}
+
+unsigned int Pipeline::getDroppedFrames() const {
+    return droppedFrames;
+}
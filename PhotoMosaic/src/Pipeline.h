@@ -0,0 +1,121 @@
+#pragma once
+#include "PhotoMosaic.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/// A Slot hands values from one thread to another, keeping only the newest.
+/// Values are swapped in and out instead of copied, so a frame buffer that
+/// travels through it is reused once it has its final size.
+template <class T>
+class Slot {
+private:
+    std::mutex mutex;
+    std::condition_variable ready;
+    T value;
+    bool full = false;
+    bool closed = false;
+    
+public:
+    /// Swap a value into the slot, dropping the value that was waiting.
+    /// Returns true if a value was dropped.
+    bool put(T& in) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::swap(value, in);
+        bool dropped = full;
+        full = true;
+        ready.notify_one();
+        return dropped;
+    }
+    
+    /// Wait for a value and swap it out. Returns false once closed.
+    bool take(T& out) {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [this] { return full || closed; });
+        if(!full) return false;
+        std::swap(value, out);
+        full = false;
+        return true;
+    }
+    
+    bool isFull() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return full;
+    }
+    
+    /// Swap out a value if one is waiting, without blocking.
+    bool tryTake(T& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(!full) return false;
+        std::swap(value, out);
+        full = false;
+        return true;
+    }
+    
+    void open() {
+        std::lock_guard<std::mutex> lock(mutex);
+        full = false;
+        closed = false;
+    }
+    
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        ready.notify_all();
+    }
+};
+
+/// A Pipeline runs PhotoMosaic::match() continuously on a stream of images,
+/// with capture, PhotoMosaic::prepare() and PhotoMosaic::match() each on
+/// their own thread. While one frame is being matched the next one is
+/// being prepared, and when a stage falls behind only the newest frame is
+/// kept. The PhotoMosaic settings should not be changed while running,
+/// except for setTransitionStyle(), addIcon() and removeIcon().
+class Pipeline {
+private:
+    PhotoMosaic& photomosaic;
+    std::function<bool(cv::Mat&)> capture;
+    
+    Slot<cv::Mat> captured;
+    Slot<Layout> prepared;
+    Slot<Layout> matched;
+    Layout current;
+    
+    std::thread captureThread, prepareThread, matchThread;
+    std::atomic<bool> running;
+    std::atomic<int> liveThreads;
+    std::atomic<unsigned int> droppedFrames;
+    
+    void captureLoop();
+    void prepareLoop();
+    void matchLoop();
+    
+public:
+    Pipeline(PhotoMosaic& photomosaic);
+    ~Pipeline();
+    
+    /// Start the threads. capture() is called repeatedly from its own thread
+    /// and should block until it has written the next RGB frame into its
+    /// argument, which is reused between calls. Return false to end the stream.
+    void start(std::function<bool(cv::Mat&)> capture);
+    
+    /// Stop the threads, waiting for the current capture() to return.
+    void stop();
+    
+    /// isRunning() stays true until all three threads have exited, even after
+    /// the stream ends. PhotoMosaic::match() must not be called until then.
+    bool isRunning() const;
+    
+    /// True when update() has a new match to apply.
+    bool isMatchReady();
+    
+    /// Call update() from the drawing thread when ready for a new transition.
+    /// If a new match is available it is applied and update() returns true.
+    bool update();
+    
+    /// The number of frames that were replaced by a newer frame before
+    /// they reached the next stage.
+    unsigned int getDroppedFrames() const;
+};
@@ -0,0 +1,169 @@
+#include "Renderer.h"
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+/// Copy the part of a tile that falls inside clip from the atlas to the canvas.
+void drawTile(cv::Mat& canvas, const cv::Rect& tile, const cv::Mat& atlas, const cv::Point2i& atlasPosition, const cv::Rect& clip) {
+    cv::Rect roi = tile & clip;
+    if(roi.empty()) return;
+    cv::Rect src(atlasPosition.x + roi.x - tile.x, atlasPosition.y + roi.y - tile.y, roi.width, roi.height);
+    atlas(src).copyTo(canvas(roi));
+}
+
+Renderer::Renderer(const PhotoMosaic& photomosaic)
+:photomosaic(photomosaic) {
+}
+
+void Renderer::setFrameRate(float frameRate) {
+    if(frameRate <= 0 || frameRate > 1000) {
+        throw std::out_of_range("frameRate is out of range");
+    }
+    this->frameRate = frameRate;
+}
+
+void Renderer::setDuration(float durationSeconds) {
+    if(durationSeconds <= 0 || durationSeconds > 3600) {
+        throw std::out_of_range("durationSeconds is out of range");
+    }
+    this->durationSeconds = durationSeconds;
+}
+
+void Renderer::setThreads(unsigned int threads) {
+    this->threads = threads;
+}
+
+void Renderer::setBackground(const cv::Scalar& background) {
+    this->background = background;
+}
+
+unsigned int Renderer::getFrameCount() const {
+    return std::max(1, int(roundf(frameRate * durationSeconds)));
+}
+
+void Renderer::render(std::function<void(const cv::Mat& frame, unsigned int index)> write, bool ordered) const {
+    unsigned int frameCount = getFrameCount();
+    unsigned int threadCount = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min(threadCount, frameCount);
+    
+    int width = photomosaic.getWidth(), height = photomosaic.getHeight();
+    int side = photomosaic.getSide();
+    int gx = width / side, gy = height / side;
+    cv::Rect screen(0, 0, width, height);
+    const std::vector<int>& tileLevels = photomosaic.getTileLevels();
+    const std::vector<unsigned int>& tileIcons = photomosaic.getTileIcons();
+    unsigned int n = tileLevels.size();
+    
+    std::mutex mutex;
+    std::condition_variable turn;
+    unsigned int nextFrame = 0;
+    std::exception_ptr error;
+    
+    auto renderThread = [&](unsigned int thread) {
+        cv::Mat canvas(height, width, CV_8UC3);
+        std::vector<cv::Point2f> positions;
+        std::vector<cv::Rect> current(n), previous;
+        std::vector<unsigned char> dirty(gx * gy);
+        
+        // ordered frames are interleaved so the threads stay close to the writer,
+        // otherwise each thread takes a contiguous run for smaller differences
+        unsigned int begin = ordered ? thread : (frameCount * thread) / threadCount;
+        unsigned int end = ordered ? frameCount : (frameCount * (thread + 1)) / threadCount;
+        unsigned int step = ordered ? threadCount : 1;
+        
+        try {
+            for(unsigned int frame = begin; frame < end; frame += step) {
+                // stop early once another thread has failed
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if(error) return;
+                }
+                float t = frameCount > 1 ? float(frame) / (frameCount - 1) : 1;
+                photomosaic.getCurrentPositions(t, positions);
+                for(unsigned int i = 0; i < n; i++) {
+                    int tileSide = photomosaic.getSide(tileLevels[i]);
+                    current[i] = cv::Rect(cvRound(positions[i].x), cvRound(positions[i].y), tileSide, tileSide);
+                }
+                
+                if(previous.empty()) {
+                    canvas = background;
+                    for(unsigned int i = 0; i < n; i++) {
+                        int level = tileLevels[i];
+                        drawTile(canvas, current[i], photomosaic.getAtlas(level),
+                                 photomosaic.getAtlasPositions(level)[tileIcons[i]], screen);
+                    }
+                } else {
+                    // mark the grid cells under the old and new rect of every moved tile
+                    std::fill(dirty.begin(), dirty.end(), 0);
+                    bool moved = false;
+                    for(unsigned int i = 0; i < n; i++) {
+                        if(current[i] == previous[i]) continue;
+                        moved = true;
+                        for(const cv::Rect& rect : {previous[i], current[i]}) {
+                            cv::Rect cells = rect & screen;
+                            if(cells.empty()) continue;
+                            for(int y = cells.y / side; y <= (cells.y + cells.height - 1) / side; y++) {
+                                for(int x = cells.x / side; x <= (cells.x + cells.width - 1) / side; x++) {
+                                    dirty[y * gx + x] = 1;
+                                }
+                            }
+                        }
+                    }
+                    
+                    // clear the dirty cells, then redraw every tile that overlaps them in order
+                    if(moved) {
+                        for(int y = 0; y < gy; y++) {
+                            for(int x = 0; x < gx; x++) {
+                                if(dirty[y * gx + x]) {
+                                    canvas(cv::Rect(x * side, y * side, side, side)) = background;
+                                }
+                            }
+                        }
+                        for(unsigned int i = 0; i < n; i++) {
+                            cv::Rect cells = current[i] & screen;
+                            if(cells.empty()) continue;
+                            int level = tileLevels[i];
+                            const cv::Mat& atlas = photomosaic.getAtlas(level);
+                            const cv::Point2i& atlasPosition = photomosaic.getAtlasPositions(level)[tileIcons[i]];
+                            for(int y = cells.y / side; y <= (cells.y + cells.height - 1) / side; y++) {
+                                for(int x = cells.x / side; x <= (cells.x + cells.width - 1) / side; x++) {
+                                    if(dirty[y * gx + x]) {
+                                        drawTile(canvas, current[i], atlas, atlasPosition, cv::Rect(x * side, y * side, side, side));
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+                previous = current;
+                
+                if(ordered) {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    turn.wait(lock, [&] { return nextFrame == frame || error; });
+                    if(error) return;
+                    write(canvas, frame);
+                    nextFrame++;
+                    turn.notify_all();
+                } else {
+                    write(canvas, frame);
+                }
+            }
+        } catch(...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(!error) error = std::current_exception();
+            turn.notify_all();
+        }
+    };
+    
+    std::vector<std::thread> workers;
+    for(unsigned int thread = 0; thread < threadCount; thread++) {
+        workers.emplace_back(renderThread, thread);
+    }
+    for(std::thread& worker : workers) {
+        worker.join();
+    }
+    if(error) {
+        std::rethrow_exception(error);
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "PhotoMosaic.h"
+#include <functional>
+
+/// A Renderer draws every frame of the current PhotoMosaic transition
+/// on the CPU from the atlases, without a window. Frames are split across
+/// threads, each with its own canvas. After the first frame of a thread
+/// only the parts of the canvas touched by tiles that moved are redrawn.
+class Renderer {
+private:
+    const PhotoMosaic& photomosaic;
+    float frameRate = 30;
+    float durationSeconds = 5;
+    unsigned int threads = 0;
+    cv::Scalar background = cv::Scalar(0, 0, 0);
+    
+public:
+    Renderer(const PhotoMosaic& photomosaic);
+    
+    void setFrameRate(float frameRate);
+    void setDuration(float durationSeconds);
+    
+    /// Defaults to the number of cores.
+    void setThreads(unsigned int threads);
+    
+    /// The color behind the tiles, visible where tiles are moving.
+    void setBackground(const cv::Scalar& background);
+    
+    /// The first frame shows t=0 and the last shows t=1.
+    unsigned int getFrameCount() const;
+    
+    /// Render every frame, calling write(frame, index) from the render threads.
+    /// The frame is only valid until write() returns. With ordered, write()
+    /// is called one frame at a time in order, for streaming to a video pipe.
+    /// Otherwise frames arrive in any order, for saving numbered images.
+    void render(std::function<void(const cv::Mat& frame, unsigned int index)> write, bool ordered=false) const;
+};
@@ -35,3 +35,21 @@ std::vector<Tile> Tile::buildTiles(const cv::Mat& mat, int subsampling) {
     }
     return tiles;
 }
+
+void Tile::buildTiles(const cv::Mat& mat, int subsampling, const std::vector<cv::Rect>& regions, std::vector<Tile>& tiles) {
+    tiles.clear();
+    tiles.reserve(regions.size());
+    int w = mat.cols, h = mat.rows;
+    cv::Vec2f center = cv::Vec2f(w-subsampling, h-subsampling) / 2;
+    float maxDistance = norm(center);
+    cv::Size wh(subsampling, subsampling);
+    cv::Mat roi;
+    for(const cv::Rect& region : regions) {
+        cv::resize(mat(region), roi, wh, 0, 0, cv::INTER_AREA);
+        // measure from the middle of the region so every tile size is weighted alike
+        cv::Vec2f position(region.x + (region.width - subsampling) / 2.f,
+                           region.y + (region.height - subsampling) / 2.f);
+        float distanceFromCenter = cv::norm(center - position) / maxDistance;
+        tiles.emplace_back(roi, 1 - distanceFromCenter);
+    }
+}
@@ -20,4 +20,8 @@ public:
     
     /// Build a vector of Tiles from a perfectly-sized image.
     static std::vector<Tile> buildTiles(const cv::Mat& mat, int subsampling);
+    
+    /// Fill a vector of Tiles from regions of an image, keeping its capacity.
+    /// Each region is resized to (subsampling x subsampling), so larger regions are averaged.
+    static void buildTiles(const cv::Mat& mat, int subsampling, const std::vector<cv::Rect>& regions, std::vector<Tile>& tiles);
 };
@@ -1,5 +1,10 @@
 #include "PhotoMosaic.h"
+#include "Pipeline.h"
+#include "Renderer.h"
 #include "ofMain.h"
+#ifndef TARGET_WIN32
+#include <csignal>
+#endif
 
 /// Load an RGB image from disk.
 cv::Mat loadMat(std::string filename) {
@@ -58,7 +63,10 @@ void addSubsection(ofMesh& mesh, ofTexture& tex, float x, float y, float w, floa
 class ofApp : public ofBaseApp {
 public:
     PhotoMosaic photomosaic;
-    ofTexture atlasTexture;
+    cv::VideoCapture camera; // declared before the pipeline, which uses it until it stops
+    Pipeline pipeline{photomosaic};
+    Renderer renderer{photomosaic};
+    std::vector<ofTexture> atlasTextures;
     
     float transitionDurationSeconds = 5;
     uint64_t lastTransitionStart = 0;
@@ -73,30 +81,154 @@ public:
         photomosaic.setRefinementSteps(1000000);
         photomosaic.setFilterScale(0.1);
         photomosaic.setFilterContrast(1.0);
+        photomosaic.setLevels(1); // use 2 or 3 for larger tiles in flat regions
+        GLint maximumTextureSize = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maximumTextureSize);
+        photomosaic.setMaximumAtlasSize(maximumTextureSize);
         photomosaic.setIcons(loadImages("db"));
         
-        // copy the atlas to a texture for rendering later
+        // copy the atlases to textures for rendering later
+        atlasTextures.resize(photomosaic.getLevels());
+        for(int level = 0; level < photomosaic.getLevels(); level++) {
+            loadAtlasTexture(level);
+        }
+    }
+    void loadAtlasTexture(int level) {
         ofPixels atlasPix;
-        const cv::Mat& atlasMat = photomosaic.getAtlas();
+        const cv::Mat& atlasMat = photomosaic.getAtlas(level);
         atlasPix.setFromExternalPixels(atlasMat.data, atlasMat.cols, atlasMat.rows, OF_PIXELS_RGB);
-        atlasTexture.allocate(atlasPix);
+        atlasTextures[level].allocate(atlasPix);
+    }
+    /// Upload only the part of the atlas that belongs to one icon,
+    /// unless the atlas has grown and the texture must be replaced.
+    void updateAtlasTexture(int level, unsigned int icon) {
+        const cv::Mat& atlasMat = photomosaic.getAtlas(level);
+        ofTexture& tex = atlasTextures[level];
+        if(tex.getWidth() != atlasMat.cols || tex.getHeight() != atlasMat.rows) {
+            loadAtlasTexture(level);
+            return;
+        }
+        int side = photomosaic.getSide(level);
+        cv::Point2i position = photomosaic.getAtlasPositions(level)[icon];
+        cv::Mat roi = atlasMat(cv::Rect(position.x, position.y, side, side)).clone();
+        const ofTextureData& data = tex.getTextureData();
+        glBindTexture(data.textureTarget, data.textureID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(data.textureTarget, 0, position.x, position.y, side, side, GL_RGB, GL_UNSIGNED_BYTE, roi.data);
+        glBindTexture(data.textureTarget, 0);
+    }
+    /// Drop .png files on the window to add them as icons.
+    void dragEvent(ofDragInfo dragInfo) {
+        for(auto& filename : dragInfo.files) {
+            if(ofToLower(ofFilePath::getFileExt(filename)) != "png") continue;
+            unsigned int icon;
+            try {
+                icon = photomosaic.addIcon(loadMat(filename));
+            } catch(const std::exception& e) {
+                ofLogError() << "could not add " << filename << ": " << e.what();
+                continue;
+            }
+            for(int level = 0; level < photomosaic.getLevels(); level++) {
+                updateAtlasTexture(level, icon);
+            }
+        }
     }
     void keyPressed(int key) {
         if(key == ' ') {
             loadPortrait("portraits/img.jpg");
         }
+        if(key == 'c') {
+            toggleCamera();
+        }
+        if(key == 'r') {
+            renderFrames("render");
+        }
+        if(key == 'v') {
+            renderVideo("render.mp4");
+        }
     }
-    void loadPortrait(string filename) {
-        if(transitionInProcess) return;
-        transitionInProcess = true; // transition starts
+    void randomizeTransitionStyle() {
         photomosaic.setTransitionStyle(ofRandomuf() < 0.5,
                                        ofRandomuf() < 0.5,
                                        ofRandomuf() < 0.5);
+    }
+    void loadPortrait(string filename) {
+        if(transitionInProcess || pipeline.isRunning()) return;
+        transitionInProcess = true; // transition starts
+        randomizeTransitionStyle();
         photomosaic.match(loadMat(filename));
         // this is how you build the result without drawing it:
         // saveMat(photomosaic.buildResult(), "output.tiff");
         lastTransitionStart = ofGetElapsedTimeMillis();
     }
+    void toggleCamera() {
+        if(pipeline.isRunning()) {
+            pipeline.stop();
+            camera.release();
+            return;
+        }
+        if(!camera.open(0)) {
+            ofLogError() << "could not open camera";
+            return;
+        }
+        // capture and decode on the pipeline's capture thread
+        pipeline.start([this](cv::Mat& frame) {
+            if(!camera.read(frame)) return false;
+            cv::cvtColor(frame, frame, cv::COLOR_BGR2RGB);
+            return true;
+        });
+    }
+    /// Render the current transition to numbered .png files in a directory.
+    void renderFrames(string directory, float frameRate=30) {
+        ofDirectory::createDirectory(directory, true, true);
+        renderer.setFrameRate(frameRate);
+        renderer.setDuration(transitionDurationSeconds);
+        renderer.render([&](const cv::Mat& frame, unsigned int index) {
+            saveMat(frame, directory + "/" + ofToString(index, 6, '0') + ".png");
+        });
+    }
+    /// Render the current transition to a video by piping raw frames to ffmpeg.
+    void renderVideo(string filename, float frameRate=30) {
+        renderer.setFrameRate(frameRate);
+        renderer.setDuration(transitionDurationSeconds);
+        string command = "ffmpeg -y -f rawvideo -pix_fmt rgb24 -s " +
+        ofToString(photomosaic.getWidth()) + "x" + ofToString(photomosaic.getHeight()) +
+        " -r " + ofToString(frameRate) +
+        " -i - -pix_fmt yuv420p \"" + ofToDataPath(filename, true) + "\"";
+#ifdef TARGET_WIN32
+        FILE* pipe = _popen(command.c_str(), "wb");
+#else
+        FILE* pipe = popen(command.c_str(), "w");
+#endif
+        if(!pipe) {
+            ofLogError() << "could not start ffmpeg";
+            return;
+        }
+        // if ffmpeg is missing or exits early, writing fails instead of killing the app
+#ifndef TARGET_WIN32
+        auto previousHandler = std::signal(SIGPIPE, SIG_IGN);
+#endif
+        try {
+            renderer.render([&](const cv::Mat& frame, unsigned int index) {
+                for(int y = 0; y < frame.rows; y++) {
+                    if(fwrite(frame.ptr(y), 3, frame.cols, pipe) != size_t(frame.cols)) {
+                        throw std::runtime_error("could not write frame " + ofToString(index) + " to ffmpeg");
+                    }
+                }
+            }, true);
+        } catch(const std::exception& e) {
+            ofLogError() << e.what();
+        }
+#ifdef TARGET_WIN32
+        int status = _pclose(pipe);
+#else
+        int status = pclose(pipe);
+        std::signal(SIGPIPE, previousHandler);
+#endif
+        if(status != 0) {
+            ofLogError() << "ffmpeg failed with status " << status;
+        }
+    }
     void update() {
         float transitionPrev = transitionStatus;
         transitionStatus = (ofGetElapsedTimeMillis() - lastTransitionStart) / (1000 * transitionDurationSeconds);
@@ -104,22 +236,42 @@ public:
         if(transitionStatus == 1 && transitionPrev < 1) {
             transitionInProcess = false; // transition finishes
         }
+        
+        // in camera mode, the newest match starts the next transition
+        if(!transitionInProcess && pipeline.isMatchReady()) {
+            randomizeTransitionStyle();
+            pipeline.update();
+            transitionInProcess = true;
+            lastTransitionStart = ofGetElapsedTimeMillis();
+        }
+    }
+    void exit() {
+        pipeline.stop();
+        camera.release();
     }
     void draw() {
-        ofMesh mesh;
-        mesh.setMode(OF_PRIMITIVE_TRIANGLES);
-        int side = photomosaic.getSide();
-        const std::vector<cv::Point2i>& atlasPositions = photomosaic.getAtlasPositions();
+        // one mesh per level, each drawn with its own atlas
+        int levels = photomosaic.getLevels();
+        std::vector<ofMesh> meshes(levels);
+        for(ofMesh& mesh : meshes) {
+            mesh.setMode(OF_PRIMITIVE_TRIANGLES);
+        }
+        const std::vector<int>& tileLevels = photomosaic.getTileLevels();
+        const std::vector<unsigned int>& tileIcons = photomosaic.getTileIcons();
         std::vector<cv::Point2f> screenPositions = photomosaic.getCurrentPositions(transitionStatus);
         int n = screenPositions.size();
         for(int i = 0; i < n; i++) {
+            int level = tileLevels[i];
+            int side = photomosaic.getSide(level);
             cv::Point2f screen = screenPositions[i];
-            cv::Point2i atlas = atlasPositions[i % atlasPositions.size()];
-            addSubsection(mesh, atlasTexture, screen.x, screen.y, side, side, atlas.x, atlas.y);
+            cv::Point2i atlas = photomosaic.getAtlasPositions(level)[tileIcons[i]];
+            addSubsection(meshes[level], atlasTextures[level], screen.x, screen.y, side, side, atlas.x, atlas.y);
+        }
+        for(int level = 0; level < levels; level++) {
+            atlasTextures[level].bind();
+            meshes[level].drawFaces();
+            atlasTextures[level].unbind();
         }
-        atlasTexture.bind();
-        mesh.drawFaces();
-        atlasTexture.unbind();
     }
 };
 